@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2012, Jared Duke.
+// This code is released under the MIT License.
+// www.opensource.org/licenses/mit-license.php
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LC_AGGREGATE_H_
+#define _LC_AGGREGATE_H_
+
+#include <cstddef>
+#include <utility>
+
+namespace lc {
+
+///////////////////////////////////////////////////////////////////////////
+// Aggregates summarize the set elements falling into each group of product_set::group_by()
+//    Each aggregate provides the following:
+//      1) first(args...)           yields the aggregate value of a group from its first candidate tuple
+//      2) next(value, args...)     accumulates a subsequent candidate tuple into the aggregate value
+//      3) merge(value, other)      combines the aggregate values of two partial groups
+//
+// e.g.:  auto sums = from(a, b).group_by([](int x, int y) { return x % 3; }, sum(std::plus<int>()));
+
+// Count the candidate tuples in each group
+struct count_aggregate {
+  template<typename... Args>
+  size_t first(const Args&...) const { return 1; }
+
+  template<typename... Args>
+  void next(size_t& value, const Args&...) const { ++value; }
+
+  void merge(size_t& value, size_t other) const { value += other; }
+};
+
+// Sum the values of f over the candidate tuples in each group
+template<typename F>
+struct sum_aggregate {
+  template<typename... Args>
+  auto first(const Args&... args) const -> decltype(std::declval<F&>()(args...)) { return f(args...); }
+
+  template<typename V, typename... Args>
+  void next(V& value, const Args&... args) const { value += f(args...); }
+
+  template<typename V>
+  void merge(V& value, const V& other) const { value += other; }
+
+  mutable F f;
+};
+
+// Find the least value of f over the candidate tuples in each group
+template<typename F>
+struct minimum_aggregate {
+  template<typename... Args>
+  auto first(const Args&... args) const -> decltype(std::declval<F&>()(args...)) { return f(args...); }
+
+  template<typename V, typename... Args>
+  void next(V& value, const Args&... args) const { const auto v = f(args...); if (v < value) value = v; }
+
+  template<typename V>
+  void merge(V& value, const V& other) const { if (other < value) value = other; }
+
+  mutable F f;
+};
+
+// Find the greatest value of f over the candidate tuples in each group
+template<typename F>
+struct maximum_aggregate {
+  template<typename... Args>
+  auto first(const Args&... args) const -> decltype(std::declval<F&>()(args...)) { return f(args...); }
+
+  template<typename V, typename... Args>
+  void next(V& value, const Args&... args) const { const auto v = f(args...); if (value < v) value = v; }
+
+  template<typename V>
+  void merge(V& value, const V& other) const { if (value < other) value = other; }
+
+  mutable F f;
+};
+
+///////////////////////////////////////////////////////////////////////////
+// Aggregate creation
+
+inline count_aggregate count() {
+  return count_aggregate();
+}
+
+template<typename F>
+sum_aggregate<F> sum(F f) {
+  return sum_aggregate<F>{ std::move(f) };
+}
+
+template<typename F>
+minimum_aggregate<F> minimum(F f) {
+  return minimum_aggregate<F>{ std::move(f) };
+}
+
+template<typename F>
+maximum_aggregate<F> maximum(F f) {
+  return maximum_aggregate<F>{ std::move(f) };
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+} // namespace lc
+
+#endif // _LC_AGGREGATE_H_
@@ -0,0 +1,132 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2012, Jared Duke.
+// This code is released under the MIT License.
+// www.opensource.org/licenses/mit-license.php
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LC_BATCH_H_
+#define _LC_BATCH_H_
+
+#include "lc_set.h"
+
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <vector>
+
+namespace lc {
+
+// A batch of queries sharing the source lists, and the filters, of a single product set
+//    Each query has its own filters and transform, and stores its results in its own list.
+//    The batch references the result lists of its queries, which must outlive it.
+//    Evaluating the batch enumerates the product set once; each candidate tuple satisfying
+//    the shared filters is dispatched to every query, so N queries cost roughly one scan.
+//
+// e.g.:  std::vector<int> a(10, 0), b(5, 1), sums, products;
+//        auto batch = shared_scan((from(a, b), [](int x, int y) { return x < y; }));
+//        batch.add(sums,     std::plus<int>())
+//             .add(products, std::multiplies<int>(), { [](int x, int) { return x > 0; } });
+//        batch();
+template< typename... Args >
+class product_batch {
+public:
+
+  typedef std::tuple<typename types<Args>::element...> tuple_type;
+  typedef product_set<tuple_type, Args...>             set_type;
+  typedef typename set_type::filter_type               filter_type;
+  typedef typename set_type::filter_list               filter_list;
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Constructors
+
+  // Construct from a product set, whose lists and filters are shared by every query
+  template< typename R >
+  product_batch(product_set<R,Args...>&& set)
+    : mSet(std::move(set)) { }
+
+  product_batch(product_batch&& other)
+    : mSet(std::move(other.mSet)),
+      mQueries(std::move(other.mQueries)) { }
+
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Methods
+
+  // Adds a query to the batch, no processing is performed
+  //    Candidates satisfying the shared filters and the query filters are transformed and stored in results
+  //    The results are referenced, not copied, and must outlive the batch
+  //    The transform must have a signature of type: R(Args...)
+  //    Each filter must have a signature of type:   bool(Args...)
+  template< typename R, typename F >
+  product_batch& add(std::vector<R>& results, F transform, std::initializer_list<filter_type> filters = {}) {
+    auto out = &results;
+    query q;
+    q.filters = filter_list(filters);
+    q.clear   = [out]() { out->clear(); };
+    q.sink    = [out, transform](const typename types<Args>::element&... args) { out->push_back(transform(args...)); };
+    mQueries.push_back(std::move(q));
+    return *this;
+  }
+
+  // Adds a query yielding the untransformed candidate tuples to the batch, no processing is performed
+  product_batch& add(std::vector<tuple_type>& results, std::initializer_list<filter_type> filters = {}) {
+    return add(results, std::make_tuple<const typename types<Args>::element&...>, filters);
+  }
+
+  // Evaluate every query in a single pass over the product set
+  //    The results of each query replace the contents of its result list, so repeated evaluations do not accumulate
+  void operator()() const {
+    for (auto q = std::begin(mQueries); q != std::end(mQueries); ++q)
+      q->clear();
+    mSet.scan([this](const typename set_type::tuple_value& v) {
+      for (auto q = std::begin(mQueries); q != std::end(mQueries); ++q) {
+        if (accepts(*q, v))
+          apply(typename set_type::tuple_indices(), v, std::cref(q->sink));
+      }
+    });
+  }
+
+  // Return the number of queries in the batch
+  size_t size() const { return mQueries.size(); }
+
+private:
+
+  product_batch(const product_batch&);
+  product_batch& operator=(const product_batch&);
+
+  struct query {
+    filter_list                                                  filters; // Filters specific to the query
+    std::function<void()>                                        clear;   // Empties the results
+    std::function<void(const typename types<Args>::element&...)> sink;    // Transforms an accepted candidate, and appends it to the results
+  };
+
+  // Return whether the candidate satisfies every filter specific to the query
+  static bool accepts(const query& q, const typename set_type::tuple_value& v) {
+    for (auto f = std::begin(q.filters); f != std::end(q.filters); ++f) {
+      if (!apply(typename set_type::tuple_indices(), v, std::cref(*f)))
+        return false;
+    }
+    return true;
+  }
+
+  ///////////////////////////////////////////////////////////////////////////
+
+  set_type                    mSet;     // The shared lists, and the filters applied before any query
+  typename types<query>::list mQueries; // The queries evaluated for each shared candidate
+};
+
+///////////////////////////////////////////////////////////////////////////
+// Batch creation
+//
+// shared_scan(set) creates an empty batch of queries over the lists and filters of set
+
+template< typename R, typename... Args >
+product_batch<Args...> shared_scan(product_set<R,Args...>&& set) {
+  return product_batch<Args...>(std::move(set));
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+} // namespace lc
+
+#endif // _LC_BATCH_H_
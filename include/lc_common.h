@@ -13,6 +13,8 @@ namespace lc {
 // Forward declaration
 
 template<typename R, typename... Args> class cartesian;
+template<typename R, typename... Args> struct product_set;
+template<typename... Args> class product_batch;
 
 } // namespace lc
 
@@ -0,0 +1,321 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2012, Jared Duke.
+// This code is released under the MIT License.
+// www.opensource.org/licenses/mit-license.php
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LC_HASH_H_
+#define _LC_HASH_H_
+
+#include "lc_utils.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace lc {
+
+///////////////////////////////////////////////////////////////////////////
+// result_hash extends std::hash to the tuples, pairs and vectors produced by list comprehensions
+
+template<typename T>
+struct result_hash : public std::hash<T> { };
+
+inline size_t hash_combine(size_t seed, size_t h) {
+  return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+template<size_t N>
+struct tuple_hash {
+  template<typename... Ts>
+  static size_t combine(size_t seed, const std::tuple<Ts...>& t) {
+    typedef typename std::tuple_element<sizeof...(Ts) - N, std::tuple<Ts...>>::type T;
+    return tuple_hash<N-1>::combine(hash_combine(seed, result_hash<T>()(std::get<sizeof...(Ts) - N>(t))), t);
+  }
+};
+
+template<>
+struct tuple_hash<0> {
+  template<typename... Ts>
+  static size_t combine(size_t seed, const std::tuple<Ts...>&) {
+    return seed;
+  }
+};
+
+template<typename... Ts>
+struct result_hash< std::tuple<Ts...> > {
+  size_t operator()(const std::tuple<Ts...>& t) const {
+    return tuple_hash<sizeof...(Ts)>::combine(0, t);
+  }
+};
+
+template<typename T1, typename T2>
+struct result_hash< std::pair<T1,T2> > {
+  size_t operator()(const std::pair<T1,T2>& p) const {
+    return hash_combine(hash_combine(0, result_hash<T1>()(p.first)), result_hash<T2>()(p.second));
+  }
+};
+
+template<typename T>
+struct result_hash< std::vector<T> > {
+  size_t operator()(const std::vector<T>& v) const {
+    size_t seed = v.size();
+    for (auto it = std::begin(v); it != std::end(v); ++it)
+      seed = hash_combine(seed, result_hash<T>()(*it));
+    return seed;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////
+// An insertion-ordered hash set, using open addressing with linear probing
+//    Each distinct value is stored once, in a dense list, and is identified by its index in that list.
+//    The probe table stores only indices, so growing the table never moves or rehashes the values.
+
+template<typename T, typename Hash = result_hash<T>, typename Eq = std::equal_to<T>>
+class hash_set {
+public:
+
+  typedef typename types<T>::list list;
+
+  explicit hash_set(Hash h = Hash(), Eq eq = Eq())
+    : mHash(std::move(h)), mEq(std::move(eq)) { }
+
+  // Insert the value if not already present
+  //    Returns the index of the value, and whether it was inserted
+  std::pair<size_t,bool> emplace(const T& value) {
+    if (2 * (mValues.size() + 1) > mSlots.size())
+      rehash(mSlots.empty() ? 16 : 2 * mSlots.size());
+
+    const size_t h    = mHash(value);
+    const size_t slot = find(value, h);
+    if (mSlots[slot] != npos)
+      return std::make_pair(mSlots[slot], false);
+
+    mSlots[slot] = mValues.size();
+    mValues.push_back(value);
+    mHashes.push_back(h);
+    return std::make_pair(mSlots[slot], true);
+  }
+
+  // Insert the value if not already present, returning whether it was inserted
+  bool insert(const T& value) {
+    return emplace(value).second;
+  }
+
+  // Return the index of the value, or npos if not present
+  size_t index(const T& value) const {
+    return mSlots.empty() ? npos : mSlots[find(value, mHash(value))];
+  }
+
+  bool contains(const T& value) const { return index(value) != npos; }
+
+  size_t size()  const { return mValues.size();  }
+  bool   empty() const { return mValues.empty(); }
+
+  // Prepare the set to hold the specified number of values without growing
+  void reserve(size_t count) {
+    size_t capacity = 16;
+    while (capacity < 2 * count)
+      capacity *= 2;
+    if (capacity > mSlots.size())
+      rehash(capacity);
+    mValues.reserve(count);
+    mHashes.reserve(count);
+  }
+
+  void clear() {
+    mValues.clear();
+    mHashes.clear();
+    std::fill(std::begin(mSlots), std::end(mSlots), npos);
+  }
+
+  // The values of the set, in order of first insertion
+  const list& values() const { return mValues; }
+
+  // Move the values of the set out, in order of first insertion, leaving the set empty
+  list release() {
+    list values;
+    std::swap(values, mValues);
+    clear();
+    return values;
+  }
+
+  static const size_t npos = static_cast<size_t>(-1);
+
+private:
+
+  // Mix the bits of the hash, as std::hash is often the identity for integral types
+  static size_t mix(size_t h) {
+    unsigned long long x = h;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+  }
+
+  // Return the slot holding the value, or the empty slot at which it would be inserted
+  size_t find(const T& value, size_t h) const {
+    const size_t mask = mSlots.size() - 1;
+    for (size_t slot = mix(h) & mask; ; slot = (slot + 1) & mask) {
+      const size_t i = mSlots[slot];
+      if (i == npos || (mHashes[i] == h && mEq(mValues[i], value)))
+        return slot;
+    }
+  }
+
+  void rehash(size_t capacity) {
+    mSlots.assign(capacity, npos);
+    const size_t mask = capacity - 1;
+    for (size_t i = 0; i < mValues.size(); ++i) {
+      size_t slot = mix(mHashes[i]) & mask;
+      while (mSlots[slot] != npos)
+        slot = (slot + 1) & mask;
+      mSlots[slot] = i;
+    }
+  }
+
+  Hash                mHash;   // Hashes values
+  Eq                  mEq;     // Compares values with equal hashes
+  list                mValues; // The distinct values, in order of insertion
+  std::vector<size_t> mHashes; // The hash of each value
+  std::vector<size_t> mSlots;  // The probe table of indices into the values, or npos if empty
+};
+
+template<typename T, typename Hash, typename Eq>
+const size_t hash_set<T,Hash,Eq>::npos;
+
+///////////////////////////////////////////////////////////////////////////
+// An insertion-ordered hash map, storing its keys in a hash_set and its values in a parallel dense list
+
+template<typename K, typename V, typename Hash = result_hash<K>, typename Eq = std::equal_to<K>>
+class hash_map {
+public:
+
+  typedef typename types<K>::list key_list;
+  typedef typename types<V>::list value_list;
+
+  explicit hash_map(Hash h = Hash(), Eq eq = Eq())
+    : mKeys(std::move(h), std::move(eq)) { }
+
+  // Update the value of the key, or insert it if the key is not already present
+  //    The init function must have a signature of type:    V()
+  //    The modify function must have a signature of type:  void(V&)
+  template<typename Init, typename Modify>
+  V& update(const K& key, Init init, Modify modify) {
+    const auto i = mKeys.emplace(key);
+    if (i.second) {
+      mValues.push_back(init());
+    } else {
+      modify(mValues[i.first]);
+    }
+    return mValues[i.first];
+  }
+
+  // Merge the entries of another map, combining the values of keys present in both
+  //    The combine function must have a signature of type:  void(V&, const V&)
+  template<typename Combine>
+  void merge(const hash_map& other, Combine combine) {
+    for (size_t i = 0; i < other.size(); ++i) {
+      const V& value = other.mValues[i];
+      update(other.keys()[i], [&]() { return value; }, [&](V& v) { combine(v, value); });
+    }
+  }
+
+  // Return the value of the key, or nullptr if not present
+  const V* find(const K& key) const {
+    const size_t i = mKeys.index(key);
+    return i != hash_set<K,Hash,Eq>::npos ? &mValues[i] : nullptr;
+  }
+
+  size_t size()  const { return mValues.size();  }
+  bool   empty() const { return mValues.empty(); }
+
+  void reserve(size_t count) {
+    mKeys.reserve(count);
+    mValues.reserve(count);
+  }
+
+  // The keys and their corresponding values, in order of first insertion
+  const key_list&   keys()   const { return mKeys.values(); }
+  const value_list& values() const { return mValues;        }
+
+private:
+
+  hash_set<K,Hash,Eq> mKeys;   // The distinct keys
+  value_list          mValues; // The value of each key, by index
+};
+
+///////////////////////////////////////////////////////////////////////////
+// A range yielding the distinct elements of another range, in order of first occurrence
+//    Duplicates are discarded as the range is iterated, so only the distinct elements are retained.
+//    The range is single-pass; each call to begin() restarts deduplication.
+//    An lvalue range is referenced and must outlive the distinct range; an rvalue range is moved into it.
+
+template<typename Range, typename Hash = result_hash<typename value_of<Range>::type>, typename Eq = std::equal_to<typename value_of<Range>::type>>
+class distinct_range {
+public:
+
+  typedef typename value_of<Range>::type                       value_type;
+  typedef decltype(std::begin(std::declval<const Range&>()))   range_iterator;
+
+  class iterator : public std::iterator<std::forward_iterator_tag, value_type, ptrdiff_t, const value_type*, const value_type&> {
+  public:
+
+    iterator() : mSeen(nullptr) { }
+
+    iterator(range_iterator it, range_iterator end, hash_set<value_type,Hash,Eq>* seen)
+      : mIt(it), mEnd(end), mSeen(seen) {
+      if (mSeen && mIt != mEnd && !mSeen->insert(*mIt))
+        advance();
+    }
+
+    const value_type& operator*()  const { return  *mIt; }
+    const value_type* operator->() const { return &*mIt; }
+    iterator&         operator++()       { advance(); return *this; }
+
+    bool operator==(const iterator& other) const { return mIt == other.mIt; }
+    bool operator!=(const iterator& other) const { return mIt != other.mIt; }
+
+  private:
+
+    void advance() {
+      while (mIt != mEnd && !(++mIt != mEnd && mSeen->insert(*mIt)))
+        ;
+    }
+
+    range_iterator                mIt;
+    range_iterator                mEnd;
+    hash_set<value_type,Hash,Eq>* mSeen;
+  };
+
+  distinct_range(const Range& range, Hash h = Hash(), Eq eq = Eq())
+    : mRange(&range), mSeen(std::move(h), std::move(eq)) { }
+
+  distinct_range(Range&& range, Hash h = Hash(), Eq eq = Eq())
+    : mOwned(new Range(std::move(range))), mRange(mOwned.get()), mSeen(std::move(h), std::move(eq)) { }
+
+  iterator begin() {
+    mSeen.clear();
+    return iterator(std::begin(*mRange), std::end(*mRange), &mSeen);
+  }
+
+  iterator end() {
+    return iterator(std::end(*mRange), std::end(*mRange), nullptr);
+  }
+
+private:
+
+  std::unique_ptr<const Range> mOwned; // The range, if moved into the distinct range
+  const Range*                 mRange; // The range whose distinct elements are yielded
+  hash_set<value_type,Hash,Eq> mSeen;  // The distinct elements yielded so far
+};
+
+///////////////////////////////////////////////////////////////////////////
+
+} // namespace lc
+
+#endif // _LC_HASH_H_
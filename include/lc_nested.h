@@ -0,0 +1,222 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2012, Jared Duke.
+// This code is released under the MIT License.
+// www.opensource.org/licenses/mit-license.php
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LC_NESTED_H_
+#define _LC_NESTED_H_
+
+#include "lc_set.h"
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace lc {
+
+///////////////////////////////////////////////////////////////////////////
+// Nested sources allow a product set to be used directly as a source of another product set,
+//    without first generating the inner set into a list.
+//
+//    As the outer-most source, the inner set is generated lazily as the outer set is iterated,
+//    so no intermediate results are stored.  As any other source, the inner set would be
+//    re-generated for every element of the preceding sources, so it is generated once and cached
+//    the first time it is walked; no processing is performed when the outer set is created.
+//    Only sets provided as rvalues are nested; a set provided as an lvalue is generated and copied,
+//    as any other container.
+//
+// e.g.:  std::vector<int> r(20);
+//        auto evens = (from(r), [](int x) { return x % 2 == 0; });
+//        auto pairs = (from(std::move(evens), r), [](int x, int y) { return x < y; });
+
+template< typename R, typename... Args >
+class nested_list {
+public:
+
+  typedef product_set<R,Args...>                                              set_type;
+  typedef typename set_type::template iterator<typename set_type::const_tuple_iter> set_iterator;
+  typedef typename types<R>::list                                             list;
+
+  class const_iterator;
+  typedef const_iterator iterator;
+  typedef R              value_type;
+
+  nested_list() : mCacheOnUse(false) { }
+
+  explicit nested_list(set_type&& set)
+    : mInner(std::make_shared<inner>(std::move(set))), mCacheOnUse(false) { }
+
+  explicit nested_list(list values)
+    : mInner(std::make_shared<inner>(std::move(values))), mCacheOnUse(false) { }
+
+  // The inner set is scanned to its first element only once, however many times the source is restarted
+  //    If marked to be cached, the inner set is generated in full the first time the source is walked
+  const_iterator begin() const { return (mCacheOnUse || cached()) ? const_iterator(mInner->values().begin()) : const_iterator(mInner->bounds().first);  }
+  const_iterator end()   const { return (mCacheOnUse || cached()) ? const_iterator(mInner->values().end())   : const_iterator(mInner->bounds().second); }
+
+  // Return an iterator to the element at the specified index, which takes constant time only if cached
+  const_iterator at(size_t index) const {
+    if (cached())
+      return const_iterator(mInner->values().begin() + index);
+    auto it = begin();
+    std::advance(it, index);
+    return it;
+  }
+
+  // Return the number of elements in the inner set, or unknown_size if not yet cached
+  //    The inner set is never generated just to count its elements
+  size_t size() const {
+    return cached() ? mInner->values().size() : unknown_size;
+  }
+
+  // Generate the inner set in full the first time the source is walked, and iterate over the generated elements from then on
+  void cacheOnFirstUse() { mCacheOnUse = true; }
+
+  // Return whether the inner set has been generated
+  bool cached() const { return mInner->cached(); }
+
+  // Return whether the inner set is iterated lazily, rather than generated in full
+  bool fused()  const { return !mCacheOnUse && !cached(); }
+
+  // Generate the inner set now if it is marked to be cached, rather than waiting for it to be walked
+  void prepare() const {
+    if (mCacheOnUse)
+      mInner->values();
+  }
+
+private:
+
+  // The inner set, shared by copies of the source, along with its bounds and generated elements once known
+  //    Each is computed once, however many threads walk the source concurrently
+  class inner {
+  public:
+
+    explicit inner(set_type&& set) : mSet(new set_type(std::move(set))), mCached(false) { }
+    explicit inner(list values)    : mValues(std::move(values)),         mCached(true)  { }
+
+    const std::pair<set_iterator,set_iterator>& bounds() const {
+      std::call_once(mBoundsOnce, [this]() { mBounds = std::make_pair(mSet->begin(), mSet->end()); });
+      return mBounds;
+    }
+
+    const list& values() const {
+      std::call_once(mValuesOnce, [this]() {
+        if (!mCached) {
+          mValues = (*mSet)();
+          mCached = true;
+        }
+      });
+      return mValues;
+    }
+
+    bool cached() const { return mCached; }
+
+  private:
+
+    std::unique_ptr<const set_type>              mSet;        // The inner set, if not generated on construction
+    mutable std::once_flag                       mBoundsOnce; // Locates the bounds of the inner set once
+    mutable std::pair<set_iterator,set_iterator> mBounds;     // The bounds of the inner set
+    mutable std::once_flag                       mValuesOnce; // Generates the inner set once
+    mutable list                                 mValues;     // The generated elements of the inner set, if cached
+    mutable std::atomic<bool>                    mCached;     // Whether the inner set has been generated
+  };
+
+  std::shared_ptr<const inner> mInner;      // The inner set
+  bool                         mCacheOnUse; // Whether to generate the inner set in full when first walked
+};
+
+// An iterator over the elements of a nested source, either generated lazily from the inner set or from its cache
+template< typename R, typename... Args >
+class nested_list<R,Args...>::const_iterator : public std::iterator<std::forward_iterator_tag, R, ptrdiff_t, const R*, const R&> {
+public:
+
+  const_iterator() : mCached(false) { }
+
+  explicit const_iterator(typename list::const_iterator it) : mList(it), mCached(true) { }
+  explicit const_iterator(set_iterator it)                  : mSet(it),  mCached(false) { }
+
+  const R&        operator*()  const { return mCached ? *mList : *mSet; }
+  const R*        operator->() const { return &**this; }
+  const_iterator& operator++()       { if (mCached) ++mList; else ++mSet; return *this; }
+
+  bool operator==(const const_iterator& other) const { return mCached ? mList == other.mList : mSet == other.mSet; }
+  bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+private:
+
+  typename list::const_iterator mList;
+  set_iterator                  mSet;
+  bool                          mCached;
+};
+
+///////////////////////////////////////////////////////////////////////////
+// Product sets are stored within another product set as a nested source
+
+template< typename R, typename... Args >
+struct types< product_set<R,Args...> > {
+  typedef typename types<R>::list list;
+  typedef nested_list<R,Args...>  source;
+  typedef R                       element;
+};
+
+template< typename R, typename... Args >
+struct source_of< product_set<R,Args...> > {
+  typedef product_set<R,Args...> type;
+};
+
+// A product set provided as an rvalue is owned by the nested source
+template< typename R, typename... Args >
+nested_list<R,Args...> toSource(product_set<R,Args...>&& s) {
+  return nested_list<R,Args...>(std::move(s));
+}
+
+// A product set provided as an lvalue is generated, and its elements are copied into the source
+//    The set is not referenced, so it need not outlive the source
+template< typename R, typename... Args >
+nested_list<R,Args...> toSource(const product_set<R,Args...>& s) {
+  return nested_list<R,Args...>(s());
+}
+
+template< typename R, typename... Args >
+nested_list<R,Args...> toSource(product_set<R,Args...>& s) {
+  return toSource(static_cast<const product_set<R,Args...>&>(s));
+}
+
+template< typename R, typename... Args >
+void cache(nested_list<R,Args...>& s) {
+  s.cacheOnFirstUse();
+}
+
+template< typename R, typename... Args >
+typename nested_list<R,Args...>::const_iterator iterator_at(const nested_list<R,Args...>& s, size_t index) {
+  return s.at(index);
+}
+
+// Nested sources may be sampled and split by index once cached, but are never generated to do so
+template< typename R, typename... Args >
+bool indexable(const nested_list<R,Args...>& s) {
+  return s.cached();
+}
+
+template< typename R, typename... Args >
+void prepare(const nested_list<R,Args...>& s) {
+  s.prepare();
+}
+
+// A set marked to be cached is described as deferred until it is generated
+template< typename R, typename... Args >
+std::string describe(const nested_list<R,Args...>& s) {
+  if (s.cached())
+    return "cached set[" + std::to_string(s.size()) + "]";
+  return std::string(s.fused() ? "fused" : "deferred") + " set[?]";
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+} // namespace lc
+
+#endif // _LC_NESTED_H_
@@ -20,8 +20,8 @@ namespace lc {
 //       auto set = (std::plus<int> | from( a, b ));
 
 template<typename F, typename R, typename... Args>
-auto operator|(F f, product_set<R,Args...>&& c) -> product_set< decltype(f(std::declval<Args>()...)), Args...> {
-  return std::move(product_set<decltype(f(std::declval<Args>()...)),Args...>(std::move(c)).select(f));
+auto operator|(F f, product_set<R,Args...>&& c) -> product_set< decltype(f(std::declval<typename types<Args>::element>()...)), Args...> {
+  return std::move(product_set<decltype(f(std::declval<typename types<Args>::element>()...)),Args...>(std::move(c)).select(f));
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -7,14 +7,74 @@
 #ifndef _LC_SET_H_
 #define _LC_SET_H_
 
+#include "lc_aggregate.h"
 #include "lc_common.h"
+#include "lc_hash.h"
 #include "lc_utils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <exception>
 #include <iterator>
 #include <initializer_list>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 
 namespace lc {
 
+// The expected cost of generating a set, as measured by product_set::estimate()
+//    Filters are evaluated on a sample of candidate tuples, and the observed
+//    selectivity is extrapolated to the full product of the source lists
+struct set_estimate {
+
+  set_estimate() : candidates(0), samples(0), matches(0), evaluations(0), exact(false) { }
+
+  // The fraction of candidate tuples expected to satisfy all filter conditions
+  double selectivity() const {
+    return samples > 0 ? static_cast<double>(matches) / samples : 0.;
+  }
+
+  // The expected number of elements in the output set
+  size_t size() const {
+    if (exact)
+      return matches;
+    const double expected = selectivity() * candidates + .5;
+    return expected < static_cast<double>(unknown_size) ? static_cast<size_t>(expected) : unknown_size;
+  }
+
+  // The number of elements the output set is confidently expected to reach, used to pre-size its storage
+  //    An exact estimate is used as is.  A sampled estimate is extrapolated from the lower bound of the
+  //    95% Wilson score interval of its selectivity, so rare matches do not over-reserve; with too few
+  //    matches to extrapolate from, nothing is reserved.
+  size_t reserve() const {
+    if (exact)
+      return matches;
+    if (matches < minimumMatches || candidates == unknown_size)
+      return 0;
+    const double z = 1.96, n = static_cast<double>(samples), p = selectivity();
+    const double lower = (p + z*z / (2*n) - z * std::sqrt(p * (1 - p) / n + z*z / (4*n*n))) / (1 + z*z / n);
+    const double expected = lower * candidates;
+    return expected < static_cast<double>(unknown_size) ? static_cast<size_t>(expected) : unknown_size;
+  }
+
+  // The expected number of filter and transform invocations needed to generate the output set
+  double cost() const {
+    const double perCandidate = samples > 0 ? static_cast<double>(evaluations) / samples : 0.;
+    return perCandidate * candidates + size();
+  }
+
+  size_t candidates;  // The number of candidate tuples in the product of the source lists
+  size_t samples;     // The number of candidate tuples evaluated
+  size_t matches;     // The number of evaluated candidates satisfying all filter conditions
+  size_t evaluations; // The number of filter invocations performed on the evaluated candidates
+  bool   exact;       // Whether every candidate was evaluated
+
+  static const size_t minimumMatches = 10; // The fewest sampled matches from which storage is pre-sized
+};
+
 
 // A utility container for generating list comprehensions
 //    Stores the following:
@@ -25,35 +85,44 @@ namespace lc {
 template< typename R, typename... Args >
 struct product_set {
 
-  typedef std::tuple<typename types<Args>::list...>                 tuple_list;
-  typedef std::tuple<typename types<Args>::list::iterator...>       tuple_iter;
-  typedef std::tuple<typename types<Args>::list::const_iterator...> const_tuple_iter;
-  typedef typename gens<sizeof...(Args)>::type                      tuple_indices;
-  typedef decltype(tuple_apply(tuple_indices(), tuple_iter(),  deref())) tuple_value;
+  typedef std::tuple<typename types<Args>::source...>                 tuple_list;
+  typedef std::tuple<typename types<Args>::source::iterator...>       tuple_iter;
+  typedef std::tuple<typename types<Args>::source::const_iterator...> const_tuple_iter;
+  typedef typename gens<sizeof...(Args)>::type                        tuple_indices;
+  typedef decltype(tuple_deref(tuple_indices(), std::declval<const const_tuple_iter&>())) tuple_value;
 
-  typedef std::function<bool(Args...)>      filter_type;
+  typedef std::function<bool(const typename types<Args>::element&...)> filter_type;
   typedef typename types<filter_type>::list filter_list;
 
-  typedef std::function<R(Args...)> transform_type;
+  typedef std::function<R(const typename types<Args>::element&...)> transform_type;
   typedef typename types<R>::list   result_list;
 
+  // The hash map produced by grouping the set by a key function and aggregating each group
+  template< typename KeyF, typename Agg >
+  struct groups {
+    typedef typename std::decay<decltype(std::declval<KeyF&>()(std::declval<typename types<Args>::element>()...))>::type       key_type;
+    typedef typename std::decay<decltype(std::declval<Agg&>().first(std::declval<typename types<Args>::element>()...))>::type value_type;
+    typedef hash_map<key_type,value_type> type;
+  };
+
   template< typename > class iterator;
   template< typename > friend class iterator;
-  template< typename,typename... > friend class product_set;
+  template< typename,typename... > friend struct product_set;
+  template< typename... > friend class product_batch;
 
   ///////////////////////////////////////////////////////////////////////////
   // Constructors
 
   // Construct from lists of types Args...
-  product_set(typename types<Args>::list... args)
+  product_set(typename types<Args>::source... args)
     : mLists(std::make_tuple(std::move(args)...)),
-      mTransform(std::make_tuple<Args...>) { }
+      mTransform(std::make_tuple<const typename types<Args>::element&...>) { cacheSources(); }
 
   // Construct from lists of types Args..., and a list of filters
-  product_set(typename types<Args>::list... args, std::initializer_list<filter_type> l)
+  product_set(typename types<Args>::source... args, std::initializer_list<filter_type> l)
     : mLists(std::make_tuple(std::move(args)...)),
       mFilters(std::move(l)),
-      mTransform(std::make_tuple<Args...>) { }
+      mTransform(std::make_tuple<const typename types<Args>::element&...>) { cacheSources(); }
 
   // Copy move constructor
   product_set(product_set&& other) {
@@ -63,8 +132,9 @@ struct product_set {
   // Copy move constructor from set with different transform type
   template<typename R2>
   product_set(product_set<R2,Args...>&& other) {
-    std::swap(mLists,   other.mLists);
-    std::swap(mFilters, other.mFilters);
+    std::swap(mLists,    other.mLists);
+    std::swap(mFilters,  other.mFilters);
+    std::swap(mEstimate, other.mEstimate);
   }
 
   // Assignment operator
@@ -79,33 +149,41 @@ struct product_set {
 
   // Adds a filter to the set, no processing is performed
   //    The filter must have a signature of type:   bool(Args...)
+  //    Any previous estimate of the set is discarded
   template< typename F >
   product_set& where(F f) {
     mFilters.push_back(filter_type(f));
+    mEstimate = set_estimate();
     return *this;
   }
 
   // Adds a list of filters to the set, no processing is performed
   //    Each filter must have a signature of type:  bool(Args...)
+  //    Any previous estimate of the set is discarded
   template< typename F >
   product_set& where(std::initializer_list<F> fs) {
     std::copy(std::begin(fs), std::end(fs), std::back_inserter(mFilters));
+    mEstimate = set_estimate();
     return *this;
   }
 
   // Sets the transform for the set, no processing is performed
   //    The transform must have a signature of type: R(Args...)
+  //    Any previous estimate of the set is discarded
   template< typename F >
   product_set& select(F f) {
     mTransform = transform_type(f);
+    mEstimate = set_estimate();
     return *this;
   }
 
   // Return the set formed by the product set of the associated lists, where
   //    1) Each candidate tuple from the source lists satisfies all filter conditions and
   //    2) Each set element is the result of transforming the candidate tuple by the member transform
+  //    If the set has been estimated, the result storage is pre-sized to a conservative bound of the estimate
   result_list operator()() const {
     result_list results;
+    results.reserve(mEstimate.reserve());
 
 #if 1
     for (const auto& r : *this)
@@ -120,10 +198,150 @@ struct product_set {
     return std::move(results);
   }
 
+  // Return the distinct elements of the output set, in order of first occurrence
+  //    Duplicates are discarded as they are generated, using an open-addressing hash set
+  //    The hash must have a signature of type:      size_t(const R&)
+  //    The equality must have a signature of type:  bool(const R&, const R&)
+  template< typename Hash = result_hash<R>, typename Eq = std::equal_to<R> >
+  result_list distinct(Hash h = Hash(), Eq eq = Eq()) const {
+    hash_set<R,Hash,Eq> seen(std::move(h), std::move(eq));
+    for (const auto& r : *this)
+      seen.insert(r);
+    return seen.release();
+  }
+
+  // Return a range over the distinct elements of the output set, in order of first occurrence
+  //   Note: As with iterators, set generation is lazy, and duplicates are discarded as the range is iterated.
+  //         Only the distinct elements are retained.  The range references the set, which must outlive it.
+  template< typename Hash = result_hash<R>, typename Eq = std::equal_to<R> >
+  distinct_range<product_set,Hash,Eq> distinct_view(Hash h = Hash(), Eq eq = Eq()) const & {
+    return distinct_range<product_set,Hash,Eq>(*this, std::move(h), std::move(eq));
+  }
+
+  // Return a range over the distinct elements of a temporary output set, which is moved into the range
+  template< typename Hash = result_hash<R>, typename Eq = std::equal_to<R> >
+  distinct_range<product_set,Hash,Eq> distinct_view(Hash h = Hash(), Eq eq = Eq()) && {
+    return distinct_range<product_set,Hash,Eq>(std::move(*this), std::move(h), std::move(eq));
+  }
+
+  // Group the candidate tuples satisfying all filter conditions by key, aggregating each group as it is generated
+  //    Only the aggregate value of each group is retained; the member transform is not applied.
+  //    The key function must have a signature of type:  K(Args...)
+  //    The aggregate must be one of count(), sum(f), minimum(f), maximum(f), or provide the same interface
+  template< typename KeyF, typename Agg >
+  typename groups<KeyF,Agg>::type group_by(KeyF key, Agg agg) const {
+    typename groups<KeyF,Agg>::type results;
+    scan([&](const tuple_value& v) { aggregate(results, v, key, agg); });
+    return results;
+  }
+
+  // Group and aggregate as group_by(), splitting the outer-most list across the specified number of threads
+  //    Each thread aggregates into its own partial table, using its own copies of the key function and aggregate,
+  //    and the partial tables are merged once all threads finish.
+  //    If the outer-most list cannot be indexed cheaply, e.g. a nested set, it is not split and a single thread is used.
+  //    An exception thrown by the key function or aggregate in any thread is rethrown once all threads finish.
+  template< typename KeyF, typename Agg >
+  typename groups<KeyF,Agg>::type group_by_parallel(KeyF key, Agg agg, size_t threads = std::thread::hardware_concurrency()) const {
+    if (!indexable(std::get<0>(mLists)))
+      return group_by(key, agg);
+
+    const size_t outer = outerSize();
+    threads = std::max<size_t>(1, std::min(threads, outer));
+
+    std::vector<typename groups<KeyF,Agg>::type> partials(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+      auto partial = &partials[t];
+      auto error   = &errors[t];
+      workers.push_back(std::thread([&, t, partial, error, key, agg]() mutable {
+        try {
+          scan(outer / threads * t + std::min(t, outer % threads),
+               outer / threads * (t + 1) + std::min(t + 1, outer % threads),
+               [&](const tuple_value& v) { aggregate(*partial, v, key, agg); });
+        } catch (...) {
+          *error = std::current_exception();
+        }
+      }));
+    }
+    for (auto w = std::begin(workers); w != std::end(workers); ++w)
+      w->join();
+    for (auto e = std::begin(errors); e != std::end(errors); ++e) {
+      if (*e)
+        std::rethrow_exception(*e);
+    }
+
+    typedef typename groups<KeyF,Agg>::value_type value_type;
+    for (size_t t = 1; t < threads; ++t)
+      partials[0].merge(partials[t], [&](value_type& a, const value_type& b) { agg.merge(a, b); });
+    return std::move(partials[0]);
+  }
+
+  // Return the number of candidate tuples in the product of the associated lists
+  //    If the product is too large to represent, unknown_size is returned
+  size_t candidates() const {
+    const auto sizes = apply(tuple_indices(), mLists, container_sizes());
+    return std::accumulate(std::begin(sizes), std::end(sizes), size_t(1), saturating_multiply);
+  }
+
+  // Estimate the size and cost of generating the set, by evaluating the filters on a random sample of candidates
+  //    If the number of samples is at least the number of candidates, every candidate is evaluated.
+  //    Sources marked to be cached when first walked are generated, so that they may be counted and sampled;
+  //    if any source cannot be indexed cheaply even so, no candidates are sampled, and the estimate reports no samples.
+  //    The estimate is retained until the filters or transform change, and is used to pre-size the result storage
+  //    of subsequent evaluations.
+  set_estimate estimate(size_t samples = 1000) const {
+    tuple_each<sizeof...(Args)>::apply(mLists, prepare_sources());
+
+    set_estimate e;
+    e.candidates = candidates();
+
+    if (e.candidates == 0) {
+      e.exact = true;
+    } else if (e.candidates != unknown_size && samples >= e.candidates) {
+      for (auto b = tupleBegin(), it = tupleBegin(), end = tupleEnd(); it != end; iterate(it, b, end))
+        evaluate(it, e);
+      e.exact = true;
+    } else if (apply(tuple_indices(), mLists, containers_indexable())) {
+      std::mt19937 rng;
+      for (size_t i = 0; i < samples; ++i) {
+        auto it = tuple_apply(tuple_indices(), mLists, container_sample<std::mt19937>(rng));
+        evaluate(it, e);
+      }
+    }
+
+    mEstimate = e;
+    return e;
+  }
+
+  // Describe the strategy used to generate the set, along with the most recent estimate, if any
+  std::string explain() const {
+    const auto descriptions = apply(tuple_indices(), mLists, container_descriptions());
+    const size_t count = candidates();
+
+    std::stringstream ss;
+    ss << "strategy:   " << (count > 0 ? "full scan" : "empty") << std::endl;
+    ss << "sources:    ";
+    for (auto d = std::begin(descriptions); d != std::end(descriptions); ++d)
+      ss << (d != std::begin(descriptions) ? " x " : "") << *d;
+    ss << std::endl;
+    ss << "candidates: " << (count != unknown_size ? std::to_string(count) : std::string("unknown")) << std::endl;
+    ss << "filters:    " << mFilters.size() << std::endl;
+    if (mEstimate.samples > 0) {
+      ss << "estimate:   " << mEstimate.size() << " results"
+         << ", selectivity " << mEstimate.selectivity()
+         << ", cost "        << mEstimate.cost()
+         << (mEstimate.exact ? " (exact)" : " (sampled)") << std::endl;
+    }
+    return ss.str();
+  }
+
   // Return an iterator to the first element of the output set
   //   Note: Set generation is lazy.  Filtering and transforming is only performed
   //         as the iterator is incremented and dereferenced.
-  iterator<const_tuple_iter> begin() const { return iterator<const_tuple_iter>(tupleBegin(), *this, true); }
+  iterator<const_tuple_iter> begin() const {
+    return !empty() ? iterator<const_tuple_iter>(tupleBegin(), *this, true) : end();
+  }
 
   // Return an iterator to the end of the output set
   //   Note: This does not refer to a valid value, and should not be dereferenced
@@ -139,11 +357,13 @@ private:
     std::swap(mLists,     other.mLists);
     std::swap(mFilters,   other.mFilters);
     std::swap(mTransform, other.mTransform);
+    std::swap(mEstimate,  other.mEstimate);
   }
 
-  // Create a tuple of values from a tuple of const iterators
-  static tuple_value valueOf(const_tuple_iter it) {
-    return tuple_apply(tuple_indices(), it,     deref());
+  // Create a tuple referencing the values of a tuple of const iterators
+  //    The values are not copied, so the tuple is only valid until the iterators are advanced
+  static tuple_value valueOf(const const_tuple_iter& it) {
+    return tuple_deref(tuple_indices(), it);
   }
 
   // Create a tuple of const iterators to the beginnings of each list in a tuple of lists
@@ -158,7 +378,11 @@ private:
 
   // Return whether the value referenced by the const iterator satisifes all filter conditions
   bool filter(const_tuple_iter& it) const {
-    const auto v = valueOf(it);
+    return filter(valueOf(it));
+  }
+
+  // Return whether the value satisifes all filter conditions
+  bool filter(const tuple_value& v) const {
     for (auto f = std::begin(mFilters); f != std::end(mFilters); ++f) {
       if (!apply(tuple_indices(), v, *f))
         return false;
@@ -166,8 +390,78 @@ private:
     return true;
   }
 
+  // Mark the sources that are re-walked for every element of the sources preceding them to be cached when first walked
+  void cacheSources() {
+    tuple_each<sizeof...(Args)>::apply(mLists, cache_inner_sources());
+  }
+
+  // Return whether any of the associated lists is empty, in which case so is their product set
+  bool empty() const {
+    return apply(tuple_indices(), mLists, containers_empty());
+  }
+
+  // Return the number of elements in the outer-most list
+  size_t outerSize() const {
+    return apply(tuple_indices(), mLists, container_sizes())[0];
+  }
+
+  // Invoke f on the value of each candidate tuple satisfying all filter conditions
+  template< typename F >
+  void scan(F f) const {
+    if (empty())
+      return;
+
+    for (auto b = tupleBegin(), it = tupleBegin(), e = tupleEnd(); it != e; iterate(it, b, e)) {
+      const auto v = valueOf(it);
+      if (filter(v))
+        f(v);
+    }
+  }
+
+  // Invoke f on the value of each candidate tuple satisfying all filter conditions,
+  //    where the outer-most list is restricted to the elements in [first, last)
+  //    The bounds are located by iterator_at(), so the outer-most list should be indexable
+  template< typename F >
+  void scan(size_t first, size_t last, F f) const {
+    if (first >= last || empty())
+      return;
+
+    auto b = tupleBegin(), e = tupleEnd();
+    std::get<0>(b) = iterator_at(std::get<0>(mLists), first);
+    std::get<0>(e) = iterator_at(std::get<0>(mLists), last);
+    for (auto it = b; it != e; iterate(it, b, e)) {
+      const auto v = valueOf(it);
+      if (filter(v))
+        f(v);
+    }
+  }
+
+  // Accumulate the candidate tuple into its group of the hash map
+  template< typename Groups, typename KeyF, typename Agg >
+  static void aggregate(Groups& groups, const tuple_value& v, KeyF& key, const Agg& agg) {
+    groups.update(apply(tuple_indices(), v, key),
+                  [&]() { return apply(tuple_indices(), v, [&](const typename types<Args>::element&... args) { return agg.first(args...); }); },
+                  [&](typename Groups::value_list::value_type& value) {
+                    apply(tuple_indices(), v, [&](const typename types<Args>::element&... args) { agg.next(value, args...); });
+                  });
+  }
+
+  // Evaluate the filters on the value referenced by the const iterator, accumulating the outcome in the estimate
+  void evaluate(const const_tuple_iter& it, set_estimate& e) const {
+    const auto v = valueOf(it);
+    auto f = std::begin(mFilters);
+    for (; f != std::end(mFilters); ++f) {
+      ++e.evaluations;
+      if (!apply(tuple_indices(), v, *f))
+        break;
+    }
+    if (f == std::end(mFilters))
+      ++e.matches;
+    ++e.samples;
+  }
+
   // Transform the value referenced by the const iterator according to the member transform
-  R transform(const_tuple_iter it) const {
+  R transform(const const_tuple_iter& it) const {
     return apply(tuple_indices(), valueOf(it), mTransform);
   }
 
@@ -176,6 +470,7 @@ private:
   tuple_list     mLists;     // A tuple containing the user-provided lists of data
   filter_list    mFilters;   // A list of filters for the candidate tuples
   transform_type mTransform; // A transform that maps filtered tuples to the output set
+  mutable set_estimate mEstimate; // The most recent estimate of the output set
 };
 
 // An iterator to the set that yields filtered and transformed set elements
@@ -205,6 +500,7 @@ public:
 
   iterator& operator=(iterator other) {
     swap(std::move(other));
+    return *this;
   }
 
   const R&  operator*()  const { update();  return  mValue; }
@@ -278,11 +574,14 @@ product_set<std::tuple<Args...>, Args...> from(const std::array<Args,Sizes>&...
   return product_set<std::tuple<Args...>, Args...>(toList(args)...);
 }
 
-// Create a product set from the specified containers, not necessarily of the same underlying type
+// Create a product set from the specified containers, not necessarily of the same container or underlying type
 //    Each container must have valid usage with std::begin() and std::end()
-template<template<typename T> class C, typename... Args>
-product_set<std::tuple<Args...>, Args...> from(C<Args>... args) {
-  return product_set<std::tuple<Args...>, Args...>(toList(args)...);
+//    Selection sources, e.g. combinations(x, 3), and other product sets may be freely mixed with ordinary containers
+template<typename... C>
+product_set<std::tuple<typename types<typename source_of<typename std::decay<C>::type>::type>::element...>,
+            typename source_of<typename std::decay<C>::type>::type...> from(C&&... args) {
+  return product_set<std::tuple<typename types<typename source_of<typename std::decay<C>::type>::type>::element...>,
+                     typename source_of<typename std::decay<C>::type>::type...>(toSource(std::forward<C>(args))...);
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,307 @@
+/////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2012, Jared Duke.
+// This code is released under the MIT License.
+// www.opensource.org/licenses/mit-license.php
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LC_SOURCES_H_
+#define _LC_SOURCES_H_
+
+#include "lc_hash.h"
+#include "lc_utils.h"
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace lc {
+
+///////////////////////////////////////////////////////////////////////////
+// Selection sources enumerate k-element selections of a single list directly,
+//    rather than scanning the k-fold product of the list and filtering out
+//    repeated or reordered tuples.
+//
+// e.g.:  std::vector<int> r(20);
+//        auto triples = (from(combinations(r, 3)),
+//                        [](const std::vector<int>& t) { return t[0]*t[0] + t[1]*t[1] == t[2]*t[2]; });
+
+enum selection_kind {
+  combination_kind,                 // Ordered indices i0 <  i1 <  ... <  ik
+  permutation_kind,                 // Distinct indices, in any order
+  combination_with_replacement_kind // Ordered indices i0 <= i1 <= ... <= ik
+};
+
+// A single selection of k elements from a list, in the order of selection
+template< typename T >
+struct selection : public std::vector<T> {
+  selection() { }
+  explicit selection(size_t k) : std::vector<T>(k) { }
+};
+
+// A source of selections of k elements from a list
+//    Selections are enumerated lazily, in lexicographic order of the selected indices
+template< typename T >
+class selection_list {
+public:
+
+  class const_iterator;
+  typedef const_iterator     iterator;
+  typedef selection<T>       value_type;
+  typedef typename types<T>::list list;
+
+  selection_list() : mK(0), mKind(combination_kind) { }
+
+  selection_list(list l, size_t k, selection_kind kind)
+    : mList(std::move(l)), mK(k), mKind(kind) { }
+
+  const_iterator begin() const { return const_iterator(mList.begin(), mList.size(), mK, mKind); }
+  const_iterator end()   const { return const_iterator(); }
+
+  // Return an iterator to the selection at the specified position in lexicographic order, or end() if there is none
+  //    The selected indices are computed directly from the position, without enumerating the preceding selections
+  const_iterator at(size_t rank) const {
+    return rank < size() ? const_iterator(mList.begin(), mList.size(), mK, mKind, rank) : end();
+  }
+
+  // Return the number of selections in the source, or unknown_size if too large to represent
+  size_t size() const {
+    const size_t n = mList.size();
+    switch (mKind) {
+    case combination_kind:
+      return binomial(n, mK);
+    case permutation_kind:
+      return falling_factorial(n, mK);
+    case combination_with_replacement_kind:
+      if (n == 0)
+        return mK == 0 ? 1 : 0;
+      return binomial(n + mK - 1, mK);
+    }
+    return 0;
+  }
+
+  const list&    source() const { return mList; }
+  size_t         k()      const { return mK;    }
+  selection_kind kind()   const { return mKind; }
+
+private:
+
+  list           mList; // The list from which elements are selected
+  size_t         mK;    // The number of elements in each selection
+  selection_kind mKind; // The kind of selection
+};
+
+// An iterator over the selections of a selection list
+//    The underlying list is referenced by an iterator to its elements, so iterators remain valid if the list is moved
+template< typename T >
+class selection_list<T>::const_iterator
+  : public std::iterator<std::forward_iterator_tag, selection<T>, ptrdiff_t, const selection<T>*, const selection<T>&> {
+public:
+
+  const_iterator() : mData(), mN(0), mKind(combination_kind), mEnd(true) { }
+
+  const_iterator(typename list::const_iterator data, size_t n, size_t k, selection_kind kind)
+    : mData(data), mN(n), mKind(kind), mIndices(k), mUsed(n, false), mValue(k), mEnd(false) { first(); }
+
+  const_iterator(typename list::const_iterator data, size_t n, size_t k, selection_kind kind, size_t rank)
+    : mData(data), mN(n), mKind(kind), mIndices(k), mUsed(n, false), mValue(k), mEnd(false) { seek(rank); }
+
+  const selection<T>& operator*()  const { return  mValue; }
+  const selection<T>* operator->() const { return &mValue; }
+  const_iterator&     operator++()       { next(); return *this; }
+
+  bool operator==(const const_iterator& other) const {
+    return mEnd == other.mEnd && (mEnd || mIndices == other.mIndices);
+  }
+  bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+private:
+
+  // Move to the lexicographically first selection, if any
+  void first() {
+    const size_t k = mIndices.size();
+    if ((mKind != combination_with_replacement_kind && k > mN) || (mN == 0 && k > 0)) {
+      mEnd = true;
+      return;
+    }
+
+    for (size_t i = 0; i < k; ++i) {
+      mIndices[i] = (mKind == combination_with_replacement_kind) ? 0 : i;
+      if (mKind == permutation_kind)
+        mUsed[i] = true;
+    }
+    update();
+  }
+
+  // Move to the selection at the specified position in lexicographic order, which must exist
+  void seek(size_t rank) {
+    const size_t k = mIndices.size();
+    if (mKind == permutation_kind) {
+      // Each choice of index at position i is followed by (n-i-1)!/(n-k)! arrangements of the remaining positions
+      for (size_t i = 0; i < k; ++i) {
+        const size_t count = falling_factorial(mN - i - 1, k - i - 1);
+        size_t skip = rank / count, v = 0;
+        rank %= count;
+        for (;; ++v) {
+          if (!mUsed[v] && skip-- == 0)
+            break;
+        }
+        mIndices[i] = v;
+        mUsed[v] = true;
+      }
+    } else {
+      // Selections with replacement of n elements correspond to combinations of n+k-1 elements,
+      //    by adding i to the index at position i
+      const bool repeat = (mKind == combination_with_replacement_kind);
+      const size_t n = repeat ? mN + k - 1 : mN;
+      for (size_t i = 0, v = 0; i < k; ++i, ++v) {
+        for (;; ++v) {
+          const size_t count = binomial(n - v - 1, k - i - 1);
+          if (rank < count)
+            break;
+          rank -= count;
+        }
+        mIndices[i] = v;
+      }
+      for (size_t i = 0; repeat && i < k; ++i)
+        mIndices[i] -= i;
+    }
+    update();
+  }
+
+  // Move to the lexicographically next selection, or to the end if there are no more
+  void next() {
+    if (mEnd)
+      return;
+
+    if (mKind == permutation_kind ? nextPermutation() : nextCombination())
+      update();
+    else
+      mEnd = true;
+  }
+
+  bool nextCombination() {
+    const size_t k = mIndices.size();
+    const bool repeat = (mKind == combination_with_replacement_kind);
+
+    // Find the right-most index that can still be incremented
+    size_t i = k;
+    while (i > 0) {
+      --i;
+      const size_t limit = repeat ? mN - 1 : mN - k + i;
+      if (mIndices[i] < limit) {
+        ++mIndices[i];
+        for (size_t j = i + 1; j < k; ++j)
+          mIndices[j] = repeat ? mIndices[i] : mIndices[j-1] + 1;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool nextPermutation() {
+    const size_t k = mIndices.size();
+
+    // Find the right-most position that can take a larger unused index,
+    //    then fill the following positions with the smallest unused indices
+    size_t i = k;
+    while (i > 0) {
+      --i;
+      mUsed[mIndices[i]] = false;
+      size_t v = mIndices[i] + 1;
+      while (v < mN && mUsed[v])
+        ++v;
+      if (v < mN) {
+        mIndices[i] = v;
+        mUsed[v] = true;
+        for (size_t j = i + 1, u = 0; j < k; ++j, ++u) {
+          while (mUsed[u])
+            ++u;
+          mIndices[j] = u;
+          mUsed[u] = true;
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void update() {
+    for (size_t i = 0; i < mIndices.size(); ++i)
+      mValue[i] = mData[mIndices[i]];
+  }
+
+  typename list::const_iterator mData;
+  size_t                        mN;
+  selection_kind                mKind;
+  std::vector<size_t>           mIndices;
+  std::vector<bool>             mUsed;
+  selection<T>                  mValue;
+  bool                          mEnd;
+};
+
+///////////////////////////////////////////////////////////////////////////
+// Selections are stored within a product set as a lazily enumerated source,
+//    while results of selections are stored as usual
+
+template< typename T >
+struct types< selection<T> > {
+  typedef std::vector< selection<T> > list;
+  typedef selection_list<T>           source;
+  typedef selection<T>                element;
+};
+
+template< typename T >
+struct result_hash< selection<T> > : public result_hash< std::vector<T> > { };
+
+template< typename T >
+const selection_list<T>& toList(const selection_list<T>& s) {
+  return s;
+}
+
+template< typename T >
+typename selection_list<T>::const_iterator iterator_at(const selection_list<T>& s, size_t index) {
+  return s.at(index);
+}
+
+// Selections are indexed by unranking, so may be sampled and split unless there are too many to count
+template< typename T >
+bool indexable(const selection_list<T>& s) {
+  return s.size() != unknown_size;
+}
+
+template< typename T >
+std::string describe(const selection_list<T>& s) {
+  static const char* names[] = { "combinations", "permutations", "combinations_with_replacement" };
+  const size_t size = s.size();
+  return std::string(names[s.kind()]) + "(" + describe(s.source()) + ", " + std::to_string(s.k()) + ")"
+       + "[" + (size != unknown_size ? std::to_string(size) : "?") + "]";
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Selection creation
+//
+// Each container must have valid usage with std::begin() and std::end()
+
+// Create a source of the k-combinations of the container, i.e., its sorted k-element subsets by position
+template< typename C >
+selection_list<typename value_of<C>::type> combinations(const C& c, size_t k) {
+  return selection_list<typename value_of<C>::type>(toList(c), k, combination_kind);
+}
+
+// Create a source of the k-permutations of the container, i.e., its ordered k-element arrangements by position
+template< typename C >
+selection_list<typename value_of<C>::type> permutations(const C& c, size_t k) {
+  return selection_list<typename value_of<C>::type>(toList(c), k, permutation_kind);
+}
+
+// Create a source of the k-combinations of the container, where each element may be selected repeatedly
+template< typename C >
+selection_list<typename value_of<C>::type> combinations_with_replacement(const C& c, size_t k) {
+  return selection_list<typename value_of<C>::type>(toList(c), k, combination_with_replacement_kind);
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+} // namespace lc
+
+#endif // _LC_SOURCES_H_
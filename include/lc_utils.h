@@ -9,8 +9,13 @@
 
 #include "lc_common.h"
 
+#include <algorithm>
 #include <functional>
+#include <iterator>
+#include <random>
+#include <string>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
 #if defined(__INTEL_COMPILER)
@@ -83,6 +88,116 @@ struct container_end {
   }
 };
 
+///////////////////////////////////////////////////////////////////////////
+// Size arithmetic saturates at unknown_size, rather than wrapping around
+//    unknown_size denotes a size too large to represent, or one not known without generating the source
+
+static const size_t unknown_size = static_cast<size_t>(-1);
+
+inline size_t saturating_multiply(size_t a, size_t b) {
+  return (a != 0 && b > unknown_size / a) ? unknown_size : a * b;
+}
+
+inline size_t gcd(size_t a, size_t b) {
+  while (b != 0) {
+    const size_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+// The number of k-element subsets of an n-element set, saturating at unknown_size
+//    Each partial product count * (n - i) / (i + 1) is reduced by its gcd before multiplying
+inline size_t binomial(size_t n, size_t k) {
+  if (k > n)
+    return 0;
+  k = std::min(k, n - k);
+  size_t count = 1;
+  for (size_t i = 0; i < k; ++i) {
+    const size_t g = gcd(count, i + 1);
+    count = saturating_multiply(count / g, (n - i) / ((i + 1) / g));
+    if (count == unknown_size)
+      return unknown_size;
+  }
+  return count;
+}
+
+// The number of k-element arrangements of an n-element set, saturating at unknown_size
+inline size_t falling_factorial(size_t n, size_t k) {
+  if (k > n)
+    return 0;
+  size_t count = 1;
+  for (size_t i = 0; i < k && count != unknown_size; ++i)
+    count = saturating_multiply(count, n - i);
+  return count;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// container_sizes collects the sizes of each provided container
+
+struct container_sizes {
+  template<typename... C>
+  inline std::vector<size_t> operator()(const C&... c) const {
+    return std::vector<size_t>{ static_cast<size_t>(c.size())... };
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////
+// containers_empty returns whether any of the provided containers is empty
+
+struct containers_empty {
+  template<typename... C>
+  inline bool operator()(const C&... c) const {
+    const bool empty[] = { false, (std::begin(c) == std::end(c))... };
+    return std::find(std::begin(empty), std::end(empty), true) != std::end(empty);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////
+// Return an iterator to the element at the specified index of a container
+//    By default, the container is walked from its beginning, which takes constant time only for random access iterators
+
+template< typename C >
+auto iterator_at(const C& c, size_t index) -> decltype( std::begin(c) ) {
+  auto it = std::begin(c);
+  std::advance(it, index);
+  return it;
+}
+
+// Return whether iterator_at() is cheap for the container, so that it may be sampled or split by index
+template< typename C >
+bool indexable(const C&) {
+  typedef typename std::iterator_traits<decltype(std::begin(std::declval<const C&>()))>::iterator_category category;
+  return std::is_base_of<std::random_access_iterator_tag, category>::value;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// containers_indexable returns whether every provided container is indexable
+
+struct containers_indexable {
+  template<typename... C>
+  inline bool operator()(const C&... c) const {
+    const bool cheap[] = { true, indexable(c)... };
+    return std::find(std::begin(cheap), std::end(cheap), false) == std::end(cheap);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////
+// container_sample yields an iterator to a uniformly chosen element of a non-empty, indexable container
+
+template<typename Rng>
+struct container_sample {
+  container_sample(Rng& rng) : mRng(&rng) { }
+
+  template<typename C>
+  inline auto operator()(const C& c) -> decltype( std::begin(c) ) {
+    return iterator_at(c, std::uniform_int_distribution<size_t>(0, c.size() - 1)(*mRng));
+  }
+
+  Rng* mRng;
+};
+
 ///////////////////////////////////////////////////////////////////////////
 // Apply an operation to each element in a variadic tuple
 
@@ -109,6 +224,34 @@ inline auto tuple_apply(seq<S...>, const TupleType& t, F& f) -> decltype( std::m
   return std::make_tuple( f( std::get<S>(t) )... );
 }
 
+///////////////////////////////////////////////////////////////////////////
+// Create a tuple referencing the values of a tuple of iterators, without copying them
+//    Iterators yielding values by reference yield const references, which remain valid until the
+//    iterators are advanced; iterators yielding values by value, e.g. of std::vector<bool>, yield copies
+
+template<int ...S, typename TupleType>
+inline auto tuple_deref(seq<S...>, const TupleType& t) -> std::tuple<decltype( *std::get<S>(t) )...> {
+  return std::tuple<decltype( *std::get<S>(t) )...>( *std::get<S>(t)... );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Apply an operation to each element in a variadic tuple, along with the index of the element
+
+template<size_t N>
+struct tuple_each {
+  template<typename TupleType, typename F>
+  static void apply(TupleType& t, F f) {
+    tuple_each<N-1>::apply(t, f);
+    f(std::get<N-1>(t), N-1);
+  }
+};
+
+template<>
+struct tuple_each<0> {
+  template<typename TupleType, typename F>
+  static void apply(TupleType&, F) { }
+};
+
 ///////////////////////////////////////////////////////////////////////////
 // Given a tuple of iterators, provide a means for advancing over the product set sequence
 //    i.e., the last iterator in the tuple is the "inner-most" iterator, the first is the outer-most
@@ -163,10 +306,31 @@ bool iterate(std::tuple<IterTypes...>& it,
 
 ///////////////////////////////////////////////////////////////////////////
 // Vector types
+//    list is used to store results, source is used to store a source list within a product set,
+//    and element is the type of each source element, as provided to filters and transforms
 
 template<typename T>
 struct types {
   typedef std::vector<T> list;
+  typedef list           source;
+  typedef T              element;
+};
+
+///////////////////////////////////////////////////////////////////////////
+// The element type of a container that provides valid calls to std::begin/end
+
+template< typename C >
+struct value_of {
+  typedef typename std::remove_const<typename std::remove_reference<decltype(*std::begin(std::declval<const C&>()))>::type>::type type;
+};
+
+///////////////////////////////////////////////////////////////////////////
+// The type identifying a container as a source within a product set
+//    By default, this is the element type of the container, and the container is stored as a list
+
+template< typename C >
+struct source_of {
+  typedef typename value_of<C>::type type;
 };
 
 /////////////////////////////////////////////////////////////////////////
@@ -194,6 +358,59 @@ typename types<T>::list toList(typename types<T>::list&& v) {
   return std::move(v);
 }
 
+/////////////////////////////////////////////////////////////////////////
+// Convert a container to the source stored within a product set
+//    By default, the container is copied as by toList
+
+template< typename C >
+typename types<typename source_of<typename std::decay<C>::type>::type>::source toSource(C&& c) {
+  return toList(static_cast<const typename std::decay<C>::type&>(c));
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Describe a source container, as reported by product_set::explain()
+
+template< typename C >
+std::string describe(const C& c) {
+  return "list[" + std::to_string(c.size()) + "]";
+}
+
+// Mark a source container that is re-walked many times to be cached when it is first walked
+//    No processing may be performed until then.  Sources stored as lists are already materialized,
+//    so this does nothing by default
+
+template< typename C >
+void cache(C&) { }
+
+// Mark each source of a product set that is re-walked for every element of the sources preceding it
+struct cache_inner_sources {
+  template<typename C>
+  void operator()(C& c, size_t index) const {
+    if (index > 0)
+      cache(c);
+  }
+};
+
+// Generate a source container marked to be cached, so that it may be counted and sampled before it is walked
+//    Sources stored as lists are already materialized, so this does nothing by default
+
+template< typename C >
+void prepare(const C&) { }
+
+struct prepare_sources {
+  template<typename C>
+  void operator()(const C& c, size_t) const {
+    prepare(c);
+  }
+};
+
+struct container_descriptions {
+  template<typename... C>
+  inline std::vector<std::string> operator()(const C&... c) const {
+    return std::vector<std::string>{ describe(c)... };
+  }
+};
+
 ///////////////////////////////////////////////////////////////////////////
 
 } // namespace lc
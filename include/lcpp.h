@@ -8,6 +8,9 @@
 #define _LCPP_H_
 
 #include "lc_set.h"
+#include "lc_batch.h"
+#include "lc_nested.h"
+#include "lc_sources.h"
 #include "lc_operators.h"
 #include "lc_ostream.h"
 
@@ -69,6 +69,43 @@ int main(int argc, char* argv[]) {
   cout << "Untransformed: " <<       (from(a, b), cond) () << endl;
   cout << "Transformed:   " << (tf | (from(a, b), cond))() << endl;
 
+  ///////////////////////////////////////////////////////////////////////////
+  // Distinct elements, with duplicates discarded as they are generated
+
+  auto sums = (tf | (from(a, b), less<int>()));
+  cout << "Sums:          " << sums.distinct() << endl;
+  cout << "Sums (lazy):   ";
+  for (const auto& s : sums.distinct_view())
+    cout << s << " ";
+  cout << endl;
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Grouping by key, aggregating each group as it is generated
+
+  auto byRemainder = (from(a, b), less<int>()).group_by([](int x, int y) { return (x + y) % 3; }, count());
+  cout << "Count of (x + y) % 3 where x < y: ";
+  for (size_t i = 0; i < byRemainder.size(); ++i)
+    cout << byRemainder.keys()[i] << ":" << byRemainder.values()[i] << " ";
+  cout << endl;
+
+  auto largest = from(a, b).group_by_parallel([](int x, int) { return x; }, maximum(tf), 4);
+  cout << "Greatest x + y by x: " << largest.values() << endl;
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Several queries over the same sources, evaluated in a single pass
+
+  vector<int> differences, products;
+  vector<tuple<int,int>> pairs;
+  auto batch = shared_scan((from(a, b), less<int>()));
+  batch.add(differences, minus<int>())
+       .add(products,    multiplies<int>(), { [](int x, int) { return x % 2 == 0; } })
+       .add(pairs,                          { [](int x, int y) { return x + y == 9; } });
+  batch();
+  cout << "Shared scan: " << endl
+            << "  x - y:          " << differences << endl
+            << "  x * y, x even:  " << products << endl
+            << "  x + y == 9:     " << pairs << endl;
+
   ///////////////////////////////////////////////////////////////////////////
   // Pythagorean triples
 
@@ -76,6 +113,38 @@ int main(int argc, char* argv[]) {
   iota(begin(r), end(r), 1);
   cout << "PythagoreanTriples: "
             << (from(r, r, r), [](int x, int y, int z) { return x < y && y < z; },
-                               [](int x, int y, int z) { return x*x + y*y == z*z; })() << endl;
+                               [](int x, int y, int z) { return x*x + y*y == z*z; })() << endl << endl;
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Estimating the cost of a set before generating it
+
+  auto triples = (from(r, r, r), [](int x, int y, int z) { return x < y && y < z; },
+                                 [](int x, int y, int z) { return x*x + y*y == z*z; });
+  triples.estimate(4000);
+  cout << "PythagoreanTriples plan: " << endl
+            << triples.explain() << endl;
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Selections of a single list, enumerated directly rather than filtered from the product set
+
+  auto sorted = (from(combinations(r, 3)), [](const vector<int>& t) { return t[0]*t[0] + t[1]*t[1] == t[2]*t[2]; });
+  cout << "PythagoreanTriples from combinations: " << sorted() << endl;
+  cout << sorted.explain() << endl;
+
+  cout << "Ordered pairs, and a separate list: " << endl
+            << (from(permutations(b, 2), a), [](const vector<int>& p, int x) { return p[0] + p[1] == x; })()
+            << endl << endl;
+
+  cout << "Multisets of size 2: " << endl
+            << from(combinations_with_replacement(vector<int>{1, 2, 3}, 2))()
+            << endl << endl;
+
+  ///////////////////////////////////////////////////////////////////////////
+  // Sets as sources of other sets, without generating the intermediate set
+
+  auto squares = (([](int x) { return x * x; }) | from(r));
+  auto pell = (from(std::move(squares), r), [](int s, int z) { return s == 2*z*z + 1; });
+  cout << "x*x == 2*z*z + 1: " << pell() << endl;
+  cout << pell.explain() << endl;
 
 }